@@ -63,7 +63,26 @@ public:
   /// Dumps all known paths to a file
   static void dump(std::ostream& out);
 
-  static Callpath create(const std::vector<FrameId>& path);
+  /// Returns the unique callpath for path.  If compress is true, repeated
+  /// cycles of frames are first collapsed into runs; see compress_recursion().
+  static Callpath create(const std::vector<FrameId>& path, bool compress = false);
+
+  /// Creates many callpaths at once, appending them to result.  Cheaper than
+  /// calling create() per path, since the path table is locked only once.
+  /// compress is as for the single-path create().
+  static void create(const std::vector< std::vector<FrameId> >& paths,
+                     std::vector<Callpath>& result, bool compress = false);
+
+  /// Dense id of this callpath in this process, assigned in order when the
+  /// path is first interned.  The null callpath is 0.
+  size_t id() const;
+
+  /// Callpath with the given dense id, in constant time.  id must be less
+  /// than num_ids().
+  static Callpath from_id(size_t id);
+
+  /// Number of dense ids assigned so far, counting the null callpath.
+  static size_t num_ids();
 
   /// Gets the ith element in the callpath.
   const FrameId& operator[](size_t i) const {
@@ -79,10 +98,16 @@ public:
   /// Writes this callpath out to a stream.
   void write_out(std::ostream& out);
 
-  /// True if other is a prefix of this callpath.
+  /// True if other is a prefix of this callpath.  If either path has
+  /// recursion runs, the frames they stand for are compared, so compressed
+  /// and uncompressed forms of the same frames match.
   bool in(const Callpath& other) const;
 
   /// Returns a new callpath containing a slice of this callpath: [start, end).
+  /// Indices are into the stored frames, so for compressed paths a run's
+  /// marker and cycle count as separate frames.  A slice must keep each run
+  /// whole or leave it out entirely; splitting one is an error, like an
+  /// index out of bounds in get().
   /// TODO: allow callpaths to be managed/unmanaged (at runtime it might make sense to
   ///       unique things but here it really doesn't.)
   Callpath slice(size_t start, size_t end);
@@ -90,6 +115,42 @@ public:
   /// Version of slice with end assumed to be size().
   Callpath slice(size_t start);
 
+  /// Number of frames this callpath stands for, counting every repetition
+  /// of its recursion runs.  Same as size() for uncompressed callpaths.
+  size_t depth() const;
+
+  /// True if this callpath contains recursion runs.  Constant time: this is
+  /// recorded when the path is interned.
+  bool compressed() const;
+
+  /// Returns the uncompressed version of this callpath.
+  Callpath expand() const;
+
+  /// Collapses repeated cycles of frames, as produced by recursion, into
+  /// runs.  Each run is a marker frame (see is_run()) followed by one copy
+  /// of the cycle.  Runs are only made where they save frames, so paths
+  /// without recursion come back unchanged.  Compressed paths are interned,
+  /// compared and serialized like any others, and expand_recursion()
+  /// recovers the original frames.
+  static void compress_recursion(const std::vector<FrameId>& path,
+                                 std::vector<FrameId>& compressed);
+
+  /// Inverse of compress_recursion().
+  static void expand_recursion(const std::vector<FrameId>& compressed,
+                               std::vector<FrameId>& path);
+
+  /// True if frame is a run marker inserted by compress_recursion().
+  static bool is_run(const FrameId& frame);
+
+  /// Marker for a run of count repetitions of the next length frames.
+  static FrameId make_run(size_t length, size_t count);
+
+  /// Number of frames in the cycle repeated by a run marker.
+  static size_t run_length(const FrameId& run);
+
+  /// Number of times a run marker's cycle is repeated.
+  static size_t run_count(const FrameId& run);
+
   /// Reads a callpath in from a stream.
   static Callpath read_in(std::istream& in);
 
@@ -125,6 +186,7 @@ private:
   friend bool operator<(const Callpath& lhs, const Callpath& rhs);
   friend bool operator>(const Callpath& lhs, const Callpath& rhs);
   friend struct callpath_path_lt;
+  friend class HeavyHitters;
 }; // Callpath
 
 
@@ -0,0 +1,44 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of the Callpath library.
+// Written by Todd Gamblin, tgamblin@llnl.gov, All rights reserved.
+// LLNL-CODE-647183
+//
+// For details, see https://github.com/scalability-llnl/callpath
+//
+// For details, see https://scalability-llnl.github.io/spack
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CALLPATH_COMM_H
+#define CALLPATH_COMM_H
+
+#include "callpath-config.h"
+#ifdef CALLPATH_HAVE_MPI
+#include <mpi.h>
+
+///
+/// Private duplicate of comm for the library's own point-to-point messages,
+/// so that they can never match sends and receives the application has
+/// pending on comm.  The duplicate is made the first time this is called
+/// for comm, so that call is collective over comm.  It is cached as an
+/// attribute of comm and freed along with it.
+///
+MPI_Comm callpath_comm(MPI_Comm comm);
+
+#endif // CALLPATH_HAVE_MPI
+#endif // CALLPATH_COMM_H
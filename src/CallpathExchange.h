@@ -0,0 +1,70 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of the Callpath library.
+// Written by Todd Gamblin, tgamblin@llnl.gov, All rights reserved.
+// LLNL-CODE-647183
+//
+// For details, see https://github.com/scalability-llnl/callpath
+//
+// For details, see https://scalability-llnl.github.io/spack
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CALLPATH_EXCHANGE_H
+#define CALLPATH_EXCHANGE_H
+
+#include "callpath-config.h"
+#ifdef CALLPATH_HAVE_MPI
+#include <mpi.h>
+
+#include <vector>
+#include "Callpath.h"
+
+class SharedCallpathTable;
+
+///
+/// Collective all-to-all exchange of callpaths over comm.
+///
+/// send[r] holds the callpaths destined for rank r, and must have one entry
+/// per rank in comm.  On return, recv[r] holds the callpaths rank r sent to
+/// this rank, in the order it sent them, translated into local Callpaths.
+///
+/// Paths are deduplicated per destination: each distinct path is packed
+/// once, along with only the modules it references, and every occurrence is
+/// sent as a small integer reference.  Buffer sizes are exchanged first;
+/// after that each destination's buffer is sent as soon as it is packed,
+/// and incoming buffers are unpacked in the order they arrive, so packing,
+/// communication and unpacking overlap.  Received paths are interned in
+/// bulk with the batch form of Callpath::create().
+///
+void exchange_callpaths(const std::vector< std::vector<Callpath> >& send,
+                        std::vector< std::vector<Callpath> >& recv,
+                        MPI_Comm comm);
+
+///
+/// Same as above, but paths bound for processes attached to the same
+/// segment as table are sent as node-wide ids (see SharedCallpathTable),
+/// without packing their frames or modules.  Paths to other processes are
+/// encoded as above.  Every process in comm must pass a table, though
+/// tables on different nodes are of course different.
+///
+void exchange_callpaths(const std::vector< std::vector<Callpath> >& send,
+                        std::vector< std::vector<Callpath> >& recv,
+                        MPI_Comm comm, SharedCallpathTable& table);
+
+#endif // CALLPATH_HAVE_MPI
+#endif // CALLPATH_EXCHANGE_H
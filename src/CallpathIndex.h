@@ -0,0 +1,168 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of the Callpath library.
+// Written by Todd Gamblin, tgamblin@llnl.gov, All rights reserved.
+// LLNL-CODE-647183
+//
+// For details, see https://github.com/scalability-llnl/callpath
+//
+// For details, see https://scalability-llnl.github.io/spack
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CALLPATH_INDEX_H
+#define CALLPATH_INDEX_H
+
+#include <stdint.h>
+#include <vector>
+#include <map>
+
+#include "Callpath.h"
+#include "FrameId.h"
+#include "ModuleId.h"
+
+///
+/// Compressed, sorted list of path ids.  Ids are stored as variable-length
+/// deltas in blocks, and the first id of each block is kept uncompressed
+/// so that intersections can skip whole blocks without decoding them.
+///
+class PostingList {
+public:
+  PostingList();
+
+  /// Appends an id.  Ids must be appended in strictly increasing order.
+  void append(uint32_t id);
+
+  /// Number of ids in the list.
+  size_t size() const { return count; }
+
+  /// Bytes used by the compressed list.
+  size_t memory() const;
+
+  /// Decodes the entire list into ids.
+  void decode(std::vector<uint32_t>& ids) const;
+
+  /// Forward iterator over the ids in a list.
+  class cursor {
+  public:
+    cursor(const PostingList& list);
+
+    /// True if the cursor is past the last id.
+    bool done() const { return block >= list->block_first.size(); }
+
+    /// Id under the cursor.  Only valid if !done().
+    uint32_t value() const { return current; }
+
+    /// Advances to the next id.
+    void next();
+
+    /// Advances to the first id >= target, skipping whole blocks when it can.
+    void skip_to(uint32_t target);
+
+  private:
+    const PostingList *list;
+    size_t block;       ///< Current block.
+    size_t pos;         ///< Byte offset of the next delta.
+    size_t left;        ///< Ids left in the current block after this one.
+    uint32_t current;   ///< Current id.
+
+    void enter(size_t block);
+  };
+
+private:
+  static const size_t BLOCK_SIZE = 64;
+
+  std::vector<uint32_t> block_first;   ///< First id of each block.
+  std::vector<uint32_t> block_offset;  ///< Offset of each block's deltas.
+  std::vector<unsigned char> data;     ///< Varint deltas after each first id.
+  uint32_t last;                       ///< Last id appended.
+  size_t count;                        ///< Number of ids.
+
+  friend class cursor;
+}; // PostingList
+
+
+///
+/// Inverted index over a collection of callpaths.  Maps each FrameId and
+/// each ModuleId to the compressed list of ids of the paths containing it,
+/// where a path's id is its position in the collection.  Queries intersect
+/// and merge these lists instead of scanning every frame of every path.
+///
+/// The index is built in parallel: threads first index disjoint ranges of
+/// paths, then each merges the posting lists for one shard of the keys.
+///
+class CallpathIndex {
+public:
+  /// Builds an index over paths using num_threads threads (0 means use
+  /// all online processors).  The index keeps a copy of paths.
+  CallpathIndex(const std::vector<Callpath>& paths, size_t num_threads = 0);
+
+  /// Number of indexed paths.
+  size_t size() const { return paths.size(); }
+
+  /// Path with the given id.
+  const Callpath& path(uint32_t id) const { return paths[id]; }
+
+  /// Posting list for a frame, or NULL if no path contains it.
+  const PostingList *find(const FrameId& frame) const;
+
+  /// Posting list for a module, or NULL if no path contains it.
+  const PostingList *find(const ModuleId& module) const;
+
+  /// Ids of paths that pass through frame.
+  void containing(const FrameId& frame, std::vector<uint32_t>& ids) const;
+
+  /// Ids of paths that touch module.
+  void containing(const ModuleId& module, std::vector<uint32_t>& ids) const;
+
+  /// Ids of paths that contain all of the frames.
+  void containing_all(const std::vector<FrameId>& frames, std::vector<uint32_t>& ids) const;
+
+  /// Ids of paths that contain any of the frames.
+  void containing_any(const std::vector<FrameId>& frames, std::vector<uint32_t>& ids) const;
+
+  /// Ids of paths p for which p.in(prefix) is true.  Candidates come from
+  /// intersecting the posting lists of prefix's frames, not counting run
+  /// markers, and only those are checked with Callpath::in().
+  void with_prefix(const Callpath& prefix, std::vector<uint32_t>& ids) const;
+
+  /// Intersects posting lists, rarest first.
+  static void intersect(std::vector<const PostingList*> lists, std::vector<uint32_t>& ids);
+
+  /// Merges posting lists.
+  static void merge(const std::vector<const PostingList*>& lists, std::vector<uint32_t>& ids);
+
+  /// Bytes used by all posting lists.
+  size_t memory() const;
+
+private:
+  typedef std::map<FrameId, PostingList> frame_map;
+  typedef std::map<ModuleId, PostingList> module_map;
+
+  std::vector<Callpath> paths;
+
+  // Keys are split into shards so each can be built by its own thread.
+  std::vector<frame_map> frame_shards;
+  std::vector<module_map> module_shards;
+
+  size_t frame_shard(const FrameId& frame) const;
+  size_t module_shard(const ModuleId& module) const;
+
+  friend struct index_builder;
+}; // CallpathIndex
+
+#endif // CALLPATH_INDEX_H
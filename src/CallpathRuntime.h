@@ -29,7 +29,20 @@
 
 #include <vector>
 #include <stdint.h>
+#include <pthread.h>
 #include "Callpath.h"
+#include "CapturePool.h"
+#include "Mutex.h"
+
+/// Frame remembered from the previous walk, for incremental stackwalks.
+struct walk_cache_frame {
+  uintptr_t cfa;  ///< Canonical frame address (stack address) of the frame.
+  uintptr_t ra;   ///< Return address into the frame.
+  FrameId id;     ///< Translated frame.
+
+  walk_cache_frame(uintptr_t c, uintptr_t r, const FrameId& i)
+    : cfa(c), ra(r), id(i) { }
+};
 
 namespace Dyninst {
 namespace Stackwalker {
@@ -51,6 +64,19 @@ public:
   /// Returns a newly-traced callpath using this runtime's walker.
   Callpath doStackwalk(size_t wrap_level = 0);
 
+  /// Records only the raw return addresses on the stack, without module
+  /// lookup or interning.  The returned handle resolves to the Callpath
+  /// that doStackwalk() would have produced here.  Raw frames live in this
+  /// runtime's capture pool; see captures().
+  DeferredCallpath captureStackwalk(size_t wrap_level = 0);
+
+  /// Pool holding frames recorded by captureStackwalk().  Use this to
+  /// resolve captures in bulk, e.g. on a background thread.
+  CapturePool& captures();
+
+  /// Translates a raw return address into a module-relative FrameId.
+  static FrameId translateAddress(uintptr_t addr);
+
   /// Total number of stackwalks done so far.
   size_t numWalks();
 
@@ -61,21 +87,83 @@ public:
   /// when walking the stack.
   void set_chop_libc(bool chop);
 
+  /// Whether doStackwalk() should reuse the outer frames of the previous
+  /// walk.  The walk stops at the first frame whose stack address and
+  /// return address match the previous walk, and the rest of the previous
+  /// walk is reused without unwinding or translating it again.  Each thread
+  /// keeps its own previous walk, so one runtime can be shared by many
+  /// threads.  Only supported with the backtrace walker; ignored otherwise.
+  /// Don't call this while other threads are walking with this runtime.
+  void set_incremental(bool incremental);
+
+  /// Number of frames reused from previous walks in incremental mode.
+  size_t reusedFrames();
+
+  /// Whether doStackwalk() and captureStackwalk() should collapse recursion
+  /// into runs (see Callpath::compress_recursion()).  Compressed walks are
+  /// also allowed to go much deeper than normal ones, since their paths
+  /// stay short.
+  void set_compress_recursion(bool compress);
+
 private:
   /// Used by doStackwalk
   Dyninst::Stackwalker::Walker *walker;
 
   // These counters keep track of stats on how many
-  // bad stackwalks we're getting.
-  size_t num_walks;  ///< total number of stackwalks.
-  size_t bad_walks;  ///< number of bad stackwalks.
+  // bad stackwalks we're getting.  Updated atomically, since walks may run
+  // on many threads.
+  volatile size_t num_walks;  ///< total number of stackwalks.
+  volatile size_t bad_walks;  ///< number of bad stackwalks.
 
   /// whether to chop calls found below __libc_start_main
   bool chop_libc_calls;
 
-  /// cached address of __libc_start_main
-  uintptr_t libc_start_main_addr;
-  bool checked_for_libc_start_main;
+  /// cached address of __libc_start_main.  Set once, by the first walk that
+  /// chops libc, under libc_lock.
+  volatile uintptr_t libc_start_main_addr;
+  volatile bool checked_for_libc_start_main;
+  Mutex libc_lock;
+
+  /// Raw frames recorded by captureStackwalk().
+  CapturePool pool;
+
+  /// Whether to do incremental stackwalks (see set_incremental()).
+  bool incremental;
+
+  /// Whether to compress recursion (see set_compress_recursion()).
+  bool compress_recursion;
+
+  /// Walk buffers and incremental walk cache of one thread.
+  struct walk_state {
+    std::vector<void*> buffer;                ///< Raw addresses of a walk.
+    std::vector<walk_cache_frame> last_walk;  ///< Last incremental walk, innermost first.
+    bool truncated;                           ///< Whether last_walk hit the frame limit.
+    Callpath last_path;                       ///< Callpath of the last incremental walk.
+    size_t reused_frames;                     ///< Frames reused by this thread.
+
+    walk_state() : truncated(false), reused_frames(0) { }
+  };
+
+  pthread_key_t walk_key;                 ///< Finds each thread's walk_state.
+  Mutex walk_lock;                        ///< Guards walk_states.
+  std::vector<walk_state*> walk_states;   ///< States of all walking threads.
+
+  /// The calling thread's walk_state, created on first use.
+  walk_state *get_walk_state();
+
+  /// Raw frames of one walk, in the stackwalker's own form.  Each walker
+  /// defines it in CallpathRuntime.C.
+  struct raw_walk;
+
+  /// Walks the stack from the caller of this function, then trims off
+  /// wrap_level frames and, with set_chop_libc(), the frames above
+  /// __libc_start_main.  doStackwalk() and captureStackwalk() both use this,
+  /// so they always see the same frames.
+  void walkFrames(raw_walk& walk, size_t wrap_level);
+
+  /// Unwinds until the walk joins state.last_walk, then updates it.
+  /// Returns the number of frames in the new walk.
+  size_t incrementalWalk(walk_state& state, size_t max_frames);
 };
 
 #endif //CALLPATH_RUNTIME_H
@@ -0,0 +1,163 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of the Callpath library.
+// Written by Todd Gamblin, tgamblin@llnl.gov, All rights reserved.
+// LLNL-CODE-647183
+//
+// For details, see https://github.com/scalability-llnl/callpath
+//
+// For details, see https://scalability-llnl.github.io/spack
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CALLPATH_SET_OPS_H
+#define CALLPATH_SET_OPS_H
+
+#include <stdint.h>
+#include <vector>
+#include <utility>
+
+#include "Callpath.h"
+#include "ModuleId.h"
+
+///
+/// Rank of each module in a set of callpaths, in order of module name.
+/// Comparing ranks orders frames exactly as frameid_string_lt does, but
+/// without comparing strings.
+///
+class ModuleRank {
+public:
+  /// Ranks all modules used by paths.
+  ModuleRank(const std::vector<Callpath>& paths);
+
+  /// Ranks all modules used by either collection.
+  ModuleRank(const std::vector<Callpath>& a, const std::vector<Callpath>& b);
+
+  /// Rank of a module.  The module must be used by the ranked paths.
+  uint32_t rank(const ModuleId& module) const {
+    const std::string *key = &module.str();
+    size_t i = slot(key);
+    while (keys[i] && keys[i] != key) {
+      i = (i + 1) & mask;
+    }
+    return ranks[i];
+  }
+
+  /// Number of ranked modules.
+  size_t size() const { return modules.size(); }
+
+private:
+  // Open-addressed hash table from module name pointers to ranks, so that
+  // lookups are a hash and a pointer compare or two.
+  std::vector<const std::string*> keys;
+  std::vector<uint32_t> ranks;
+  size_t mask;
+
+  std::vector<ModuleId> modules;   ///< Ranked modules.
+
+  size_t slot(const std::string *key) const {
+    uintptr_t h = reinterpret_cast<uintptr_t>(key) >> 4;
+    return (h ^ (h >> 12)) & mask;
+  }
+
+  void add_modules(const std::vector<Callpath>& paths);
+  void add_module(const ModuleId& module);
+  void build();
+};
+
+
+///
+/// Orders callpaths the same way as callpath_path_lt, so the order is the
+/// same in every process, but compares module ranks instead of names.
+/// Frames that are identical are skipped with a pointer compare.
+///
+struct callpath_rank_lt {
+  const ModuleRank *ranks;
+
+  callpath_rank_lt(const ModuleRank& r) : ranks(&r) { }
+
+  bool operator()(const Callpath& lhs, const Callpath& rhs) const {
+    if (lhs == rhs) return false;
+    if (!lhs) return true;
+    if (!rhs) return false;
+
+    size_t size = (lhs.size() < rhs.size()) ? lhs.size() : rhs.size();
+    for (size_t i=0; i < size; i++) {
+      const FrameId& l = lhs[i];
+      const FrameId& r = rhs[i];
+      if (!(l.module == r.module)) {
+        return ranks->rank(l.module) < ranks->rank(r.module);
+      } else if (l.offset != r.offset) {
+        return l.offset < r.offset;
+      }
+    }
+    return lhs.size() < rhs.size();
+  }
+};
+
+
+/// A callpath and a metric for it, e.g. time spent there or a call count.
+typedef std::pair<Callpath, double> callpath_metric;
+
+/// One entry in a diff of two profiles.
+struct callpath_delta {
+  Callpath path;
+  double before;   ///< Metric in the first profile; 0 if the path isn't there.
+  double after;    ///< Metric in the second profile; 0 if the path isn't there.
+
+  callpath_delta(const Callpath& p, double b, double a)
+    : path(p), before(b), after(a) { }
+
+  /// Change in the metric from before to after.
+  double delta() const { return after - before; }
+};
+
+
+//
+// Sorted set operations over large collections of callpaths.  Each one
+// removes duplicates and produces results in callpath_path_lt order.
+// Sorting runs on num_threads threads (0 means use all online processors),
+// and each path is tagged with integer keys made from the ranks and
+// offsets of its two innermost frames, so callpath_rank_lt only has to
+// break ties.  Inputs need not be sorted.  Callpaths read in
+// with Callpath::read_in() or unpack() are interned like any others, so
+// profiles from other processes or files can be used directly.
+//
+
+/// Sorts paths in callpath_path_lt order, in parallel.
+void sort_callpaths(std::vector<Callpath>& paths, size_t num_threads = 0);
+
+/// Paths in a, b, or both.
+void callpath_union(const std::vector<Callpath>& a, const std::vector<Callpath>& b,
+                    std::vector<Callpath>& result, size_t num_threads = 0);
+
+/// Paths in both a and b.
+void callpath_intersection(const std::vector<Callpath>& a, const std::vector<Callpath>& b,
+                           std::vector<Callpath>& result, size_t num_threads = 0);
+
+/// Paths in a but not in b.
+void callpath_difference(const std::vector<Callpath>& a, const std::vector<Callpath>& b,
+                         std::vector<Callpath>& result, size_t num_threads = 0);
+
+/// Diffs two profiles.  Metrics for paths that occur more than once in a
+/// profile are summed.  result gets one entry for each path in either
+/// profile.
+void diff_callpaths(const std::vector<callpath_metric>& before,
+                    const std::vector<callpath_metric>& after,
+                    std::vector<callpath_delta>& result, size_t num_threads = 0);
+
+#endif // CALLPATH_SET_OPS_H
@@ -0,0 +1,127 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of the Callpath library.
+// Written by Todd Gamblin, tgamblin@llnl.gov, All rights reserved.
+// LLNL-CODE-647183
+//
+// For details, see https://github.com/scalability-llnl/callpath
+//
+// For details, see https://scalability-llnl.github.io/spack
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CALLPATH_TREE_H
+#define CALLPATH_TREE_H
+
+#include "callpath-config.h"
+#ifdef CALLPATH_HAVE_MPI
+#include <mpi.h>
+#endif // CALLPATH_HAVE_MPI
+
+#include <map>
+#include <vector>
+#include <iostream>
+
+#include "Callpath.h"
+#include "FrameId.h"
+#include "RankSet.h"
+
+class Translator;
+
+///
+/// Prefix tree of merged callpaths, in the style of STAT.  The root stands
+/// for the outermost frame (e.g. main), and every node records the set of
+/// ranks whose callpaths passed through it.  Useful for finding where the
+/// processes of a hung job are stuck: ranks doing the same thing share a
+/// branch, and outliers stand out.
+///
+/// Trees from many processes are merged with reduce(), which uses a
+/// binomial tree over MPI so that no single process receives more than
+/// log(P) messages.
+///
+class CallpathTree {
+public:
+  /// Node in the tree: a frame, the ranks that passed through it, and its
+  /// callees.
+  struct node {
+    FrameId frame;
+    RankSet ranks;
+    std::map<FrameId, node*> children;
+
+    node(const FrameId& f) : frame(f) { }
+    ~node();
+
+    /// Gets the child for frame f, creating it if necessary.
+    node *child(const FrameId& f);
+  };
+
+  CallpathTree();
+  ~CallpathTree();
+
+  /// Adds a callpath observed on the given rank.
+  void add(const Callpath& path, int rank);
+
+  /// Merges another tree into this one.
+  void merge(const CallpathTree& other);
+
+  /// Root of the tree.  The root has no frame of its own; its children are
+  /// the outermost frames.
+  const node *root() const { return root_node; }
+
+  /// Number of nodes in the tree, not counting the root.
+  size_t num_nodes() const;
+
+  /// Removes everything from the tree.
+  void clear();
+
+  /// Writes the tree, one frame per line, indented by depth, followed by
+  /// the ranks that reached each frame.  Frames are symbolized with the
+  /// translator and laid out the way Translator::write_path() does.
+  void write(std::ostream& out, Translator& translator) const;
+
+  /// Writes the tree with raw module(offset) frames.
+  void write(std::ostream& out) const;
+
+#ifdef CALLPATH_HAVE_MPI
+  /// Upper bound on the packed size of this tree.
+  size_t packed_size(MPI_Comm comm) const;
+
+  /// Packs this tree, with its module names, into an MPI buffer.
+  void pack(void *buf, int bufsize, int *position, MPI_Comm comm) const;
+
+  /// Unpacks a tree packed with pack() and merges it into this one.
+  void unpack_merge(void *buf, int bufsize, int *position, MPI_Comm comm);
+
+  /// Collectively merges the trees of all processes in comm.  On return,
+  /// root holds the merged tree and all other processes hold empty trees.
+  void reduce(MPI_Comm comm, int root = 0);
+#endif // CALLPATH_HAVE_MPI
+
+private:
+  node *root_node;
+
+  // Trees own their nodes and are not copyable.
+  CallpathTree(const CallpathTree&);
+  CallpathTree& operator=(const CallpathTree&);
+}; // CallpathTree
+
+inline std::ostream& operator<<(std::ostream& out, const CallpathTree& tree) {
+  tree.write(out);
+  return out;
+}
+
+#endif // CALLPATH_TREE_H
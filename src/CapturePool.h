@@ -0,0 +1,168 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of the Callpath library.
+// Written by Todd Gamblin, tgamblin@llnl.gov, All rights reserved.
+// LLNL-CODE-647183
+//
+// For details, see https://github.com/scalability-llnl/callpath
+//
+// For details, see https://scalability-llnl.github.io/spack
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CALLPATH_CAPTURE_POOL_H
+#define CALLPATH_CAPTURE_POOL_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <vector>
+#include <deque>
+
+#include "Callpath.h"
+#include "Mutex.h"
+#include "safe_bool.h"
+
+class CapturePool;
+
+///
+/// Lightweight handle to a raw stack capture stored in a CapturePool.
+/// Handles are cheap to copy and resolve to a Callpath on demand; the
+/// Callpath is cached in the pool, so resolving twice is cheap.
+///
+class DeferredCallpath : public safe_bool<DeferredCallpath> {
+public:
+  DeferredCallpath() : pool(NULL), index(0), generation(0) { }  ///< Construct a null handle.
+
+  /// Translates and interns the captured frames.  Null handles, and handles
+  /// dropped by CapturePool::reset(), resolve to a null Callpath.
+  Callpath resolve() const;
+
+  /// True if this handle refers to a capture.
+  bool boolean_test() const {
+    return pool;
+  }
+
+private:
+  CapturePool *pool;  ///< Pool that owns the raw frames.
+  size_t index;       ///< Index of the capture within the pool.
+  size_t generation;  ///< Pool generation the capture belongs to.
+
+  DeferredCallpath(CapturePool *p, size_t i, size_t g) : pool(p), index(i), generation(g) { }
+  friend class CapturePool;
+}; // DeferredCallpath
+
+
+///
+/// Pool of raw return-address arrays awaiting translation into Callpaths.
+/// Frames are appended to large preallocated blocks so that capturing a
+/// stack costs little more than the unwind itself.  Module lookup and
+/// interning happen later, either per handle via DeferredCallpath::resolve()
+/// or in bulk with resolve_all(), optionally on a background thread.
+///
+/// Captures stay in the pool until reset(), which drops them all at once
+/// and recycles their blocks for new captures.  A long-running caller should
+/// resolve the captures it wants and then reset() the pool periodically, so
+/// the pool's memory stays bounded.
+///
+class CapturePool {
+public:
+  /// Construct a pool that stores frames in blocks of block_size addresses.
+  CapturePool(size_t block_size = 1 << 16);
+
+  /// Waits for any running resolver thread and frees all raw frames.
+  ~CapturePool();
+
+  /// Copies num_frames raw return addresses into the pool and returns a
+  /// handle to them.  If compress is true, the capture resolves to a path
+  /// with recursion compressed (see Callpath::compress_recursion()).
+  DeferredCallpath add(const uintptr_t *frames, size_t num_frames, bool compress = false);
+
+  /// Number of captures recorded since the last reset().
+  size_t size();
+
+  /// Bytes of raw frame storage held by the pool, including recycled blocks.
+  size_t memory();
+
+  /// Resolves the capture with the given index.  Safe to call concurrently
+  /// with add() and with a running resolver thread.
+  Callpath resolve(size_t index);
+
+  /// Drops all captures, resolved or not, and keeps their blocks for reuse.
+  /// Waits for the resolver thread first.  Handles from before the reset
+  /// resolve to a null Callpath afterwards.  Don't call this while other
+  /// threads are resolving handles from before the reset.
+  void reset();
+
+  /// Resolves every capture that has not been resolved yet.
+  void resolve_all();
+
+  /// Runs resolve_all() on a background thread.  Captures added after the
+  /// thread starts may or may not be resolved by it.  Does nothing if a
+  /// resolver thread is already running.
+  void start_resolver();
+
+  /// Waits for the background resolver, if any, to finish.
+  void join_resolver();
+
+private:
+  /// One raw stack capture and, once resolved, its Callpath.
+  struct capture {
+    const uintptr_t *frames;
+    size_t num_frames;
+    bool compress;    ///< Whether to compress recursion when resolving.
+    Callpath path;
+    bool resolved;
+
+    capture(const uintptr_t *f, size_t n, bool c)
+      : frames(f), num_frames(n), compress(c), resolved(false) { }
+  };
+
+  size_t block_size;                ///< Number of addresses per block.
+  std::vector<uintptr_t*> blocks;   ///< Storage for raw frames.
+  size_t block_used;                ///< Addresses used in the last block.
+  std::vector<uintptr_t*> free_blocks;  ///< Blocks recycled by reset().
+  std::vector<uintptr_t*> big_blocks;   ///< Blocks for oversized captures.
+  size_t big_size;                  ///< Addresses in big_blocks.
+
+  /// Deque, because it never moves elements when it grows.
+  std::deque<capture> captures;
+  size_t resolved_upto;             ///< All captures below this are resolved.
+  size_t generation;                ///< Number of reset()s so far.
+
+  pthread_t resolver;               ///< Background resolver thread.
+  bool resolver_running;            ///< Whether resolver needs to be joined.
+
+  Mutex lock;                       ///< Guards everything above.
+  Mutex join_lock;                  ///< Serializes join_resolver().
+
+  /// Reserves space for n addresses in the pool's blocks.
+  uintptr_t *allocate(size_t n);
+
+  /// Resolves a capture if it's still from the given generation.
+  Callpath resolve(size_t index, size_t generation);
+
+  /// Entry point for the resolver thread.
+  static void *resolver_main(void *pool);
+
+  friend class DeferredCallpath;
+
+  // Pools own raw memory and are not copyable.
+  CapturePool(const CapturePool&);
+  CapturePool& operator=(const CapturePool&);
+}; // CapturePool
+
+#endif // CALLPATH_CAPTURE_POOL_H
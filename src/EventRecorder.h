@@ -0,0 +1,180 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of the Callpath library.
+// Written by Todd Gamblin, tgamblin@llnl.gov, All rights reserved.
+// LLNL-CODE-647183
+//
+// For details, see https://github.com/scalability-llnl/callpath
+//
+// For details, see https://scalability-llnl.github.io/spack
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CALLPATH_EVENT_RECORDER_H
+#define CALLPATH_EVENT_RECORDER_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+
+#include "Callpath.h"
+#include "ModuleId.h"
+#include "Mutex.h"
+
+/// One timed event, as stored in an event log.
+struct callpath_event {
+  uint64_t time;     ///< Nanoseconds, from EventRecorder::now() unless given.
+  uint64_t payload;  ///< Caller's data, e.g. a byte count or a duration.
+  uint32_t path;     ///< Log-local id of the callpath; 0 is the null path.
+  uint32_t thread;   ///< Recorder-local index of the recording thread.
+};
+
+
+///
+/// Records timed events tagged with callpaths into an append-only binary
+/// log.  Each thread appends events to its own buffer without locking, and
+/// a full buffer is written out as one block.  A callpath is given a small
+/// id and its frames are written to the log only the first time any thread
+/// records it; modules are likewise written once.  Use EventReader to
+/// replay a log.
+///
+/// Log format, after an 8-byte magic number.  Integers marked vl are
+/// variable-length (see io_utils::vl_write()):
+///
+///   MODULE  id:vl length:vl name[length]
+///   PATH    id:vl num_frames:vl (module:vl offset:vl)*
+///   EVENTS  count:vl callpath_event[count]   (raw, native byte order)
+///
+/// Every module and path is defined before the first block that uses it.
+///
+class EventRecorder {
+public:
+  /// Creates (or truncates) the log file.  Each thread buffers block_size
+  /// events before writing them out.
+  EventRecorder(const std::string& filename, size_t block_size = 1 << 14);
+
+  /// Closes the log; see close().
+  ~EventRecorder();
+
+  /// True if the log was opened successfully and all writes succeeded.
+  bool good();
+
+  /// Records an event at the current time.  Thread-safe, and takes no
+  /// locks unless this thread's buffer fills up or path is new to it.
+  void record(const Callpath& path, uint64_t payload = 0) {
+    record(path, payload, now());
+  }
+
+  /// Records an event with a caller-supplied timestamp.
+  void record(const Callpath& path, uint64_t payload, uint64_t time);
+
+  /// Writes out the calling thread's buffered events.
+  void flush();
+
+  /// Writes out every thread's buffered events and closes the log.  No
+  /// thread may record while or after this runs.
+  void close();
+
+  /// Current monotonic time in nanoseconds.
+  static uint64_t now();
+
+private:
+  /// Events and path ids for one recording thread.
+  struct thread_buffer {
+    EventRecorder *recorder;
+    uint32_t thread;
+    callpath_event *events;
+    size_t used;
+
+    std::vector<uint32_t> ids;  ///< Log ids of recorded paths, by Callpath::id().
+    Callpath last_path;         ///< Most recently recorded path...
+    uint32_t last_id;           ///< ...and its id.
+  };
+
+  size_t block_size;      ///< Events per thread buffer.
+  pthread_key_t key;      ///< Finds each thread's buffer.
+
+  Mutex lock;             ///< Guards everything below.
+  std::ofstream log;      ///< Log file.
+  bool closed;            ///< Whether close() was called.
+  std::vector<thread_buffer*> buffers;       ///< Buffers of all threads.
+  std::vector<uint32_t> path_ids;     ///< Log ids of paths seen, by Callpath::id().
+  std::vector<uint32_t> module_ids;   ///< Log ids of modules seen, by ModuleId::id().
+  uint32_t num_paths;                 ///< Paths defined in the log.
+  uint32_t num_modules;               ///< Modules defined in the log.
+  std::ostringstream definitions;     ///< Definitions not yet written.
+
+  /// The calling thread's buffer, created on first use.
+  thread_buffer *get_buffer();
+
+  /// Id of path, defining it if it's new.  Caller holds lock.
+  uint32_t define(const Callpath& path);
+
+  /// Id of module, defining it if it's new.  Caller holds lock.
+  uint32_t define(const ModuleId& module);
+
+  /// Writes pending definitions and then buf's events.  Caller holds lock.
+  void write_block(thread_buffer *buf);
+
+  /// Flushes a thread's buffer when the thread exits.
+  static void thread_exit(void *buf);
+
+  // Recorders own a file and thread-specific data; not copyable.
+  EventRecorder(const EventRecorder&);
+  EventRecorder& operator=(const EventRecorder&);
+}; // EventRecorder
+
+
+///
+/// Streams events back out of a log written by EventRecorder.  Callpaths
+/// and modules are interned as their definitions are read, so ids in each
+/// event can be turned into Callpaths with path().
+///
+class EventReader {
+public:
+  /// Opens a log for reading.
+  EventReader(const std::string& filename);
+
+  /// True if the log was opened and has a valid header.
+  bool good() const { return valid; }
+
+  /// Reads the next event.  Returns false at the end of the log, or if
+  /// the log is truncated or corrupt.
+  bool next(callpath_event& event);
+
+  /// Callpath for an id from an event that has been read.
+  Callpath path(uint32_t id) const;
+
+  /// Number of callpaths defined so far.
+  size_t num_paths() const { return paths.size(); }
+
+private:
+  std::ifstream log;
+  bool valid;
+  std::vector<ModuleId> modules;        ///< Modules by id.
+  std::vector<Callpath> paths;          ///< Callpaths by id.
+  std::vector<callpath_event> block;    ///< Current block of events.
+  size_t position;                      ///< Next event in block.
+
+  /// Reads chunks until a block of events is loaded.
+  bool read_block();
+}; // EventReader
+
+#endif // CALLPATH_EVENT_RECORDER_H
@@ -47,6 +47,22 @@ struct FrameInfo {
   void write(std::ostream& out, size_t file_line_width=0, size_t sym_width=0) const;
 };
 
+/// Column widths that line up several FrameInfos, as in a stack trace.
+/// Call fit() on each of them, then pass the widths to FrameInfo::write().
+struct frame_columns {
+  size_t max_file;
+  size_t max_line;
+  size_t max_sym;
+
+  frame_columns() : max_file(0), max_line(0), max_sym(0) { }
+
+  /// Widens the columns to fit info.
+  void fit(const FrameInfo& info);
+
+  size_t file_line_width() const { return max_file + max_line + 3; }
+  size_t sym_width() const { return max_sym + 2; }
+};
+
 inline std::ostream& operator<<(std::ostream& out, const FrameInfo& info) {
   info.write(out);
   return out;
@@ -0,0 +1,162 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of the Callpath library.
+// Written by Todd Gamblin, tgamblin@llnl.gov, All rights reserved.
+// LLNL-CODE-647183
+//
+// For details, see https://github.com/scalability-llnl/callpath
+//
+// For details, see https://scalability-llnl.github.io/spack
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CALLPATH_HEAVY_HITTERS_H
+#define CALLPATH_HEAVY_HITTERS_H
+
+#include "callpath-config.h"
+#ifdef CALLPATH_HAVE_MPI
+#include <mpi.h>
+#endif // CALLPATH_HAVE_MPI
+
+#include <stdint.h>
+#include <vector>
+
+#include "Callpath.h"
+#include "ModuleId.h"
+
+///
+/// Tracks the most frequent callpaths in a fixed amount of memory.
+///
+/// Counts go into a count-min sketch: depth rows of width counters, each
+/// indexed by a different hash of the path.  A path's estimated count is
+/// the minimum of its counters, which never underestimates and, with
+/// probability 1 - e^-depth, overestimates by at most e/width times the
+/// total count.  Alongside the sketch, a fixed table of candidate paths
+/// remembers which paths have had the largest estimates; when it is full,
+/// new paths replace the smallest candidate near their hash slot.
+///
+/// add() is lock-free and can be called from any number of threads on the
+/// same tracker.  Trackers with the same dimensions can be merged, locally
+/// with merge() or across processes with pack()/unpack_merge().  Paths are
+/// hashed by module name and offset, not by address, so sketches from
+/// different processes line up.
+///
+class HeavyHitters {
+public:
+  /// A reported heavy hitter.  The true count of path is in
+  /// [count - error, count].
+  struct entry {
+    Callpath path;
+    uint64_t count;   ///< Estimated count (an upper bound).
+    uint64_t error;   ///< Maximum overestimate, with high probability.
+  };
+
+  /// Constructs a tracker with depth rows of width counters, and room for
+  /// capacity candidate paths.
+  HeavyHitters(size_t width = 4096, size_t depth = 4, size_t capacity = 1024);
+  ~HeavyHitters();
+
+  /// Adds count occurrences of path.  Lock-free.
+  void add(const Callpath& path, uint64_t count = 1);
+
+  /// Estimated count for path.  Never less than the true count.
+  uint64_t estimate(const Callpath& path) const;
+
+  /// Total of all counts added so far.
+  uint64_t total() const;
+
+  /// Bound on how far estimates may exceed true counts: e/width * total().
+  uint64_t error_bound() const;
+
+  /// Gets the k candidates with the largest estimates, largest first.
+  void top(size_t k, std::vector<entry>& result) const;
+
+  /// Adds the counts and candidates from other into this tracker.  Both
+  /// must have the same dimensions.  Not safe to call concurrently with
+  /// add() on other.
+  void merge(const HeavyHitters& other);
+
+  /// Bytes of memory used by the sketch and candidate table.
+  size_t memory() const;
+
+#ifdef CALLPATH_HAVE_MPI
+  /// Upper bound on the packed size of this tracker.
+  size_t packed_size(MPI_Comm comm) const;
+
+  /// Packs the sketch and candidate callpaths into an MPI buffer.  As with
+  /// Callpath::pack(), the receiver needs an id_map from
+  /// ModuleId::pack_id_map() to unpack it.  Don't add() to this tracker
+  /// between packed_size() and pack().
+  void pack(void *buf, int bufsize, int *position, MPI_Comm comm) const;
+
+  /// Unpacks a tracker packed with pack() and merges it into this one.
+  void unpack_merge(const ModuleId::id_map& modules,
+                    void *buf, int bufsize, int *position, MPI_Comm comm);
+
+  /// Collectively merges the trackers of all processes in comm into the
+  /// one on root, using a binomial tree.  Other processes' trackers are
+  /// left as they were: processes in the middle of the tree merge into a
+  /// temporary copy.  Don't add() to this tracker during the reduction.
+  void reduce(MPI_Comm comm, int root = 0);
+#endif // CALLPATH_HAVE_MPI
+
+private:
+  /// Memoized hash of a module name, keyed by its unique string.
+  struct module_hash {
+    volatile uintptr_t module;
+    volatile uint64_t hash;
+  };
+
+  /// Candidate path and the last estimate seen for it.
+  struct candidate {
+    volatile uintptr_t path;
+    volatile uint64_t estimate;
+  };
+
+  size_t width;
+  size_t depth;
+  size_t capacity;
+  volatile uint64_t *counters;    ///< depth rows of width counters.
+  candidate *candidates;          ///< capacity candidate slots.
+  volatile uint64_t total_count;
+
+  /// Small table of module name hashes, so paths can be hashed by content
+  /// without rehashing module names every time.
+  mutable module_hash module_hashes[256];
+
+  /// Process-independent hash of a callpath's frames.
+  uint64_t hash(const Callpath& path) const;
+
+  /// Hash of a module name, memoized in module_hashes.
+  uint64_t hash_module(const ModuleId& module) const;
+
+  /// Index of the counter in the given row for a path hash.
+  size_t counter_index(uint64_t hash, size_t row) const;
+
+  /// Estimate for a path with the given hash.
+  uint64_t estimate(uint64_t hash) const;
+
+  /// Makes path a candidate if it's estimated to be hotter than the
+  /// coldest candidate near its slot.
+  void offer(const Callpath& path, uint64_t hash, uint64_t estimate);
+
+  // Trackers own their tables and are not copyable.
+  HeavyHitters(const HeavyHitters&);
+  HeavyHitters& operator=(const HeavyHitters&);
+}; // HeavyHitters
+
+#endif // CALLPATH_HEAVY_HITTERS_H
@@ -33,6 +33,10 @@ class ModuleId : public UniqueId<ModuleId> {
 public:
   ModuleId();
   ModuleId(const std::string& id);
+
+private:
+  ModuleId(const std::string *id) : UniqueId<ModuleId>(id) { }
+  friend class UniqueId<ModuleId>;
 };
 
 #endif // MODULE_ID_H
@@ -0,0 +1,67 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of the Callpath library.
+// Written by Todd Gamblin, tgamblin@llnl.gov, All rights reserved.
+// LLNL-CODE-647183
+//
+// For details, see https://github.com/scalability-llnl/callpath
+//
+// For details, see https://scalability-llnl.github.io/spack
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CALLPATH_MUTEX_H
+#define CALLPATH_MUTEX_H
+
+#include <pthread.h>
+
+///
+/// Thin wrapper around a pthread mutex.  Used to protect the global tables
+/// of uniqued callpaths and module names, so that callpaths can be interned
+/// from threads other than the one that walked the stack.
+///
+class Mutex {
+public:
+  Mutex()  { pthread_mutex_init(&mutex, NULL); }
+  ~Mutex() { pthread_mutex_destroy(&mutex); }
+
+  void lock()   { pthread_mutex_lock(&mutex); }
+  void unlock() { pthread_mutex_unlock(&mutex); }
+
+private:
+  pthread_mutex_t mutex;
+
+  // Mutexes are not copyable.
+  Mutex(const Mutex&);
+  Mutex& operator=(const Mutex&);
+};
+
+
+/// Holds a Mutex for the lifetime of the enclosing scope.
+class ScopedLock {
+public:
+  ScopedLock(Mutex& m) : mutex(m) { mutex.lock(); }
+  ~ScopedLock() { mutex.unlock(); }
+
+private:
+  Mutex& mutex;
+
+  ScopedLock(const ScopedLock&);
+  ScopedLock& operator=(const ScopedLock&);
+};
+
+#endif // CALLPATH_MUTEX_H
@@ -0,0 +1,98 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of the Callpath library.
+// Written by Todd Gamblin, tgamblin@llnl.gov, All rights reserved.
+// LLNL-CODE-647183
+//
+// For details, see https://github.com/scalability-llnl/callpath
+//
+// For details, see https://scalability-llnl.github.io/spack
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CALLPATH_RANK_SET_H
+#define CALLPATH_RANK_SET_H
+
+#include "callpath-config.h"
+#ifdef CALLPATH_HAVE_MPI
+#include <mpi.h>
+#endif // CALLPATH_HAVE_MPI
+
+#include <vector>
+#include <utility>
+#include <iostream>
+
+///
+/// Compressed set of MPI ranks, stored as sorted, non-adjacent [start, end)
+/// ranges.  Sets of contiguous ranks, which are the common case when
+/// merging stack traces, take constant space regardless of how many ranks
+/// they contain.
+///
+class RankSet {
+public:
+  RankSet() { }
+
+  /// Adds a single rank to the set.
+  void insert(int rank);
+
+  /// Adds all ranks in [start, end) to the set.
+  void insert(int start, int end);
+
+  /// Adds all ranks in other to this set.
+  void merge(const RankSet& other);
+
+  /// True if rank is in the set.
+  bool contains(int rank) const;
+
+  /// Number of ranks in the set.
+  size_t size() const;
+
+  /// Number of ranges used to represent the set.
+  size_t num_ranges() const { return ranges.size(); }
+
+  /// True if the set is empty.
+  bool empty() const { return ranges.empty(); }
+
+  /// Writes the set as a comma-separated list of ranks and ranges, e.g.
+  /// "0-3,7,9-12".
+  void write(std::ostream& out) const;
+
+#ifdef CALLPATH_HAVE_MPI
+  /// Upper bound on the packed size of this set.
+  size_t packed_size(MPI_Comm comm) const;
+
+  /// Packs this set into an MPI buffer.
+  void pack(void *buf, int bufsize, int *position, MPI_Comm comm) const;
+
+  /// Unpacks a set packed with pack() and merges it into this one.
+  void unpack_merge(void *buf, int bufsize, int *position, MPI_Comm comm);
+#endif // CALLPATH_HAVE_MPI
+
+  bool operator==(const RankSet& other) const { return ranges == other.ranges; }
+  bool operator!=(const RankSet& other) const { return ranges != other.ranges; }
+
+private:
+  typedef std::pair<int, int> range;  ///< [start, end)
+  std::vector<range> ranges;
+};
+
+inline std::ostream& operator<<(std::ostream& out, const RankSet& ranks) {
+  ranks.write(out);
+  return out;
+}
+
+#endif // CALLPATH_RANK_SET_H
@@ -0,0 +1,177 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of the Callpath library.
+// Written by Todd Gamblin, tgamblin@llnl.gov, All rights reserved.
+// LLNL-CODE-647183
+//
+// For details, see https://github.com/scalability-llnl/callpath
+//
+// For details, see https://scalability-llnl.github.io/spack
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CALLPATH_SHARED_CALLPATH_TABLE_H
+#define CALLPATH_SHARED_CALLPATH_TABLE_H
+
+#include "callpath-config.h"
+#ifdef CALLPATH_HAVE_MPI
+#include <mpi.h>
+#endif // CALLPATH_HAVE_MPI
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "Callpath.h"
+#include "ModuleId.h"
+#include "Mutex.h"
+
+struct shared_table_header;
+
+///
+/// Node-wide table of module names and callpath frame arrays, kept in a
+/// shared memory segment.  Every process that attaches to the same segment
+/// gets the same ids for the same modules and callpaths, so processes on a
+/// node can exchange 64-bit ids directly instead of packing paths and
+/// translating module addresses through an id_map.
+///
+/// Insertion is lock-free: records are appended to a shared arena with an
+/// atomic fetch-and-add and published into open-addressed hash tables with
+/// compare-and-swap.  Records are never removed.  Ids are offsets into the
+/// segment; id 0 is the null module or null callpath, and is also what
+/// insertion returns if the segment is full.
+///
+/// The table does not reduce memory.  It is a node-wide id space layered
+/// over the normal interning, not a replacement for it: ModuleIds and
+/// Callpaths are pointers into each process's own tables, so every process
+/// still interns its own copies, and the segment comes on top of that.
+/// What it saves is translation.  Node ids are cached in flat arrays indexed
+/// by the local dense ids (see Callpath::id()), and local handles are cached
+/// in flat arrays indexed by record, so after the first lookup each way a
+/// translation is an array access.  The overload of exchange_callpaths()
+/// that takes a table uses this to send node ids to processes attached to
+/// the same segment, instead of packing paths and modules.
+///
+/// Constructors throw std::runtime_error if the segment can't be set up,
+/// including when attaching waits more than INIT_TIMEOUT seconds for the
+/// creating process.
+///
+class SharedCallpathTable {
+public:
+  /// Default segment size, in bytes.
+  static const size_t DEFAULT_SIZE = 64 << 20;
+
+  /// Seconds to wait for another process to initialize the segment.
+  static const int INIT_TIMEOUT = 30;
+
+  /// Attaches to the POSIX shared memory segment with the given name (e.g.
+  /// "/callpath.<jobid>"), creating and initializing it if this is the first
+  /// process to get there.  All processes must pass the same size.  Throws
+  /// std::runtime_error if the segment can't be opened, sized or mapped,
+  /// if it isn't initialized within INIT_TIMEOUT seconds, or if it was
+  /// created with a different size.
+  SharedCallpathTable(const std::string& name, size_t size = DEFAULT_SIZE);
+
+#ifdef CALLPATH_HAVE_MPI
+  /// Collectively allocates one segment per node with MPI_Win_allocate_shared,
+  /// shared by all processes of comm on the same node.  Throws
+  /// std::runtime_error if the node's segment couldn't be allocated or
+  /// initialized.
+  SharedCallpathTable(MPI_Comm comm, size_t size = DEFAULT_SIZE);
+#endif // CALLPATH_HAVE_MPI
+
+  /// Detaches from the segment.  A POSIX segment persists until unlink() is
+  /// called.  For a table built from a communicator, this frees the window
+  /// with MPI_Win_free, so it is collective: every process of the
+  /// communicator must destroy its table, before MPI_Finalize().
+  ~SharedCallpathTable();
+
+  /// Removes a named POSIX segment.  Processes already attached keep it.
+  static void unlink(const std::string& name);
+
+  /// True if the segment was attached successfully.
+  bool valid() const;
+
+  /// Node-wide id for a module, inserting it if necessary.
+  uint64_t module_id(const ModuleId& module);
+
+  /// Local module for a node-wide module id.
+  ModuleId module(uint64_t id);
+
+  /// Node-wide id for a callpath, inserting it if necessary.
+  uint64_t path_id(const Callpath& path);
+
+  /// Local callpath for a node-wide callpath id.
+  Callpath path(uint64_t id);
+
+  /// Number of distinct modules in the table.
+  size_t num_modules() const;
+
+  /// Number of distinct callpaths in the table.
+  size_t num_paths() const;
+
+  /// Token identifying the segment.  Processes attached to the same segment
+  /// get the same nonzero value, so they can tell whether their node ids
+  /// mean the same thing.  0 if the table isn't valid.
+  uint64_t segment() const;
+
+private:
+  char *base;                        ///< Start of the mapped segment.
+  size_t size;                       ///< Size of the mapped segment.
+  shared_table_header *header;       ///< Header at start of segment.
+
+#ifdef CALLPATH_HAVE_MPI
+  MPI_Win win;                       ///< Window, if allocated with MPI.
+  bool have_win;
+#endif // CALLPATH_HAVE_MPI
+
+  // Node ids of local modules and paths, indexed by their dense ids.
+  // 0 means not looked up yet.
+  std::vector<uint64_t> module_ids;
+  std::vector<uint64_t> path_ids;
+
+  // Local modules and paths, indexed by the record index stored with each
+  // module or path in the segment.  Null means not looked up yet.
+  std::vector<ModuleId> local_modules;
+  std::vector<Callpath> local_paths;
+  Mutex lock;                        ///< Guards the caches.
+
+  /// Lays out an empty table in the segment.  Only one process does this.
+  void init_segment();
+
+  /// Spins until the creating process has initialized the segment.  Throws
+  /// if that takes longer than INIT_TIMEOUT, or if the segment is invalid.
+  void wait_for_init();
+
+  /// Node id for a module.  Caller holds lock.
+  uint64_t cached_module_id(const ModuleId& module);
+
+  /// Local module for a nonzero node id.  Caller holds lock.
+  ModuleId cached_module(uint64_t id);
+
+  /// Reserves len bytes in the shared arena.  Returns 0 when full.
+  uint64_t allocate(size_t len);
+
+  uint64_t insert_module(const std::string& name);
+  uint64_t insert_path(const Callpath& path);
+
+  // Tables own the mapping and are not copyable.
+  SharedCallpathTable(const SharedCallpathTable&);
+  SharedCallpathTable& operator=(const SharedCallpathTable&);
+}; // SharedCallpathTable
+
+#endif // CALLPATH_SHARED_CALLPATH_TABLE_H
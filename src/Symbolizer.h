@@ -0,0 +1,102 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2010-2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of the Callpath library.
+// Written by Todd Gamblin, tgamblin@llnl.gov, All rights reserved.
+// LLNL-CODE-647183
+//
+// For details, see https://github.com/scalability-llnl/callpath
+//
+// For details, see https://scalability-llnl.github.io/spack
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CALLPATH_SYMBOLIZER_H
+#define CALLPATH_SYMBOLIZER_H
+
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+#include "FrameId.h"
+#include "FrameInfo.h"
+#include "ModuleId.h"
+#include "Mutex.h"
+
+///
+/// Online counterpart to Translator.  Looks up function names for FrameIds
+/// from the dynamic symbol tables of modules already mapped into this
+/// process, so it never touches the filesystem.  Each module's table is
+/// found with dl_iterate_phdr() and sorted into an address index the first
+/// time a frame in that module is looked up.
+///
+/// Only symbols the dynamic linker can see are available: .symtab is not
+/// part of any loaded segment, so static functions and functions in
+/// executables linked without -rdynamic have no name.  name() returns names
+/// as they appear in the table, i.e. mangled; translate() demangles them.
+///
+/// Lookups are thread-safe.  Modules that weren't found are looked up again
+/// once the dynamic linker reports new loads, so modules loaded later with
+/// dlopen() are picked up automatically.  Modules must stay loaded while
+/// their names are in use; call clear() after a dlclose().
+///
+class Symbolizer {
+public:
+  Symbolizer();
+  ~Symbolizer();
+
+  /// Name of the function containing frame, or NULL if it is unknown.
+  /// The name points into the module's mapped string table.
+  const char *name(const FrameId& frame);
+
+  /// FrameInfo with the demangled symbol name for frame, like
+  /// Translator::translate() but without file and line information.  Each
+  /// name is demangled once, on first use, and kept until clear().
+  FrameInfo translate(const FrameId& frame);
+
+  /// Should be true if frames contain return addresses (the default).  Names
+  /// are then looked up one byte before the offset, so that a call at the
+  /// very end of a function is attributed to that function.
+  void set_callsite_mode(bool mode);
+
+  /// Drops all indexed modules.  They are indexed again on the next lookup.
+  void clear();
+
+private:
+  class module_symbols;
+  typedef std::map<ModuleId, module_symbols*> cache;
+
+  cache modules;       ///< Index for each module found so far.
+
+  /// Modules that weren't found, and the number of module loads the dynamic
+  /// linker had reported when they were looked up.
+  std::map<ModuleId, unsigned long long> misses;
+
+  Mutex lock;          ///< Guards modules and misses.
+  bool callsite_mode;  ///< See set_callsite_mode().
+
+  /// Finds or builds the index for module.
+  module_symbols *get_module(ModuleId module);
+
+  /// Offset to look up for frame (see set_callsite_mode()).
+  uintptr_t lookup_offset(const FrameId& frame) const;
+
+  // Symbolizers own their indexes and are not copyable.
+  Symbolizer(const Symbolizer&);
+  Symbolizer& operator=(const Symbolizer&);
+}; // Symbolizer
+
+#endif // CALLPATH_SYMBOLIZER_H
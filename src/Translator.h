@@ -75,6 +75,9 @@ private:
   /// Cache of all symbtabs seen so far.
   cache symtabs;
 
+  /// Translates a frame that isn't a recursion run.
+  FrameInfo translate_frame(const FrameId& frame);
+
   /// Reads in a symbol table for the module specified.  Aborts on failure.
   symtab_info *get_symtab_info(ModuleId module);
 
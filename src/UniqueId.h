@@ -31,10 +31,12 @@
 #include <string>
 #include <set>
 #include <map>
+#include <vector>
 #include <ostream>
 
 #include "safe_bool.h"
 #include "io_utils.h"
+#include "Mutex.h"
 
 #include "callpath-config.h"
 #ifdef CALLPATH_HAVE_MPI
@@ -50,6 +52,13 @@ struct dereference_lt {
   }
 };
 
+/// Interned string along with its dense id.  Every UniqueId points to one.
+struct unique_string : public std::string {
+  size_t id;  ///< Sequential id, in order of interning.
+
+  unique_string(const std::string& str, size_t i) : std::string(str), id(i) { }
+};
+
 /// Class to represent internally-uniqued strings.  Much like symbols in ruby or lisp,
 /// this keeps an internal set of pointers to unique std::strings.
 ///
@@ -62,9 +71,17 @@ struct dereference_lt {
 ///    class MyUniqueIdClass : public UniqueId<MyUniqueIdClass> {
 ///    public:
 ///        MyUniqueIdClass(const std::string& id) : UniqueId<MyUniqueIdClass>(id) { }
+///    private:
+///        MyUniqueIdClass(const std::string *id) : UniqueId<MyUniqueIdClass>(id) { }
+///        friend class UniqueId<MyUniqueIdClass>;
 ///    };
 ///
-/// That's all!
+/// That's all!  The private constructor is used by from_id().
+///
+/// Each unique value also gets a dense id when it is first seen: the null
+/// (empty) value is 0 and the rest are numbered sequentially.  Ids are much
+/// smaller than pointers, so they are what the serialization routines below
+/// write, and they can index flat arrays.
 ///
 template <class Derived>
 class UniqueId
@@ -75,8 +92,8 @@ public:
   typedef std::set<const std::string*, dereference_lt> id_set;
   typedef typename id_set::iterator id_set_iterator;
 
-  /// Map type for translating ids from remote processes.  This maps unintptr_t's
-  /// (remote pointer values) to local string*'s.  It needs to be specially constructed
+  /// Map type for translating ids from remote processes.  This maps remote dense
+  /// ids to local values.  It needs to be specially constructed
   /// using static routines below.
   typedef std::map<uintptr_t, Derived> id_map;
 
@@ -89,11 +106,38 @@ protected:
     return ids;
   }
 
+  /// Guards the identifier set so that ids can be looked up from any thread.
+  static Mutex& get_lock() {
+    static Mutex lock;
+    return lock;
+  }
+
+  /// Unique strings, indexed by their dense ids.
+  static std::vector<const std::string*>& get_id_table() {
+    static std::vector<const std::string*> table;
+    return table;
+  }
+
+  /// Makes a unique copy of str with the next id.  Caller holds get_lock().
+  static const std::string *make_unique(const std::string& str) {
+    std::vector<const std::string*>& table = get_id_table();
+    const std::string *unique = new unique_string(str, table.size());
+    table.push_back(unique);
+    return unique;
+  }
+
   const std::string *lookup(const std::string& id) {
+    ScopedLock guard(get_lock());
     id_set& ids = get_identifiers();
+
+    // the null id is always number 0.
+    if (ids.empty() && !id.empty()) {
+      ids.insert(make_unique(""));
+    }
+
     id_set_iterator i = ids.find(&id);
     if (i == ids.end()) {
-      i = ids.insert(new std::string(id)).first;
+      i = ids.insert(make_unique(id)).first;
     }
     return *i;
   }
@@ -138,6 +182,24 @@ public:
     return identifier->c_str();
   }
 
+  /// Dense id of this value in this process.  0 for the null value.
+  size_t id() const {
+    return static_cast<const unique_string*>(identifier)->id;
+  }
+
+  /// Value with the given dense id, in constant time.  id must be less
+  /// than num_ids().
+  static Derived from_id(size_t id) {
+    ScopedLock guard(get_lock());
+    return Derived(get_id_table()[id]);
+  }
+
+  /// Number of dense ids assigned so far.
+  static size_t num_ids() {
+    ScopedLock guard(get_lock());
+    return get_id_table().size();
+  }
+
   const std::string& str() const {
     return *identifier;
   }
@@ -155,8 +217,10 @@ public:
     return Derived(buf);
   }
 
+  /// Writes the dense id.  Readers translate it with an id_map built from
+  /// write_out()s of the same values.
   void write_id(std::ostream& out) const {
-    io_utils::vl_write(out, reinterpret_cast<uintptr_t>(identifier));
+    io_utils::vl_write(out, id());
   }
 
   static Derived read_id(const id_map& trans, std::istream& in) {
@@ -202,55 +266,72 @@ public:
   }
 
   // ----------------------------------------------------------------------------------
-  // Below routines pack UniqueIds by id.  They require that you first send an id_map
-  // that the receiver can use to translate remote ids, but can be more efficient than
-  // sending raw strings as above.  See below for routines for transferring id_maps.
+  // Below routines pack UniqueIds by dense id.  They require that you first send an
+  // id_map that the receiver can use to translate remote ids, but can be more efficient
+  // than sending raw strings as above.  See below for routines for transferring id_maps.
   // ----------------------------------------------------------------------------------
 
-  /// Returns size of raw identifier.
+  /// Returns size of a packed id.
   size_t packed_size_id(MPI_Comm comm) const {
-    return pmpi_packed_size(1, MPI_UINTPTR_T, comm);
+    return pmpi_packed_size(1, MPI_UINT32_T, comm);
   }
 
-  /// Packs raw identifier onto a buffer.  Receiver will need an id_map to translate.
+  /// Packs dense id onto a buffer.  Receiver will need an id_map to translate.
   void pack_id(void *buf, int bufsize, int *position, MPI_Comm comm) const {
-    const std::string** casted = const_cast<const std::string**>(&identifier);
-    PMPI_Pack(casted, 1, MPI_UINTPTR_T, buf, bufsize, position, comm);
+    uint32_t dense = id();
+    PMPI_Pack(&dense, 1, MPI_UINT32_T, buf, bufsize, position, comm);
   }
 
-  /// Unpacks remote raw identifier and builds a local unique id using the id_map supplied.
+  /// Unpacks remote dense id and builds a local unique id using the id_map supplied.
   static Derived unpack_id(const id_map& remote_to_local, void *buf, int bufsize, int *position, MPI_Comm comm) {
-    uintptr_t remote_addr;
-    PMPI_Unpack(buf, bufsize, position, &remote_addr, 1, MPI_UINTPTR_T, comm);
-    return remote_to_local.find(remote_addr)->second;
+    uint32_t remote_id;
+    PMPI_Unpack(buf, bufsize, position, &remote_id, 1, MPI_UINT32_T, comm);
+    return remote_to_local.find(remote_id)->second;
   }
 
   // ----------------------------------------------------------------------------------
   // Below routines are for sending id_maps between processes.
   // ----------------------------------------------------------------------------------
-  /// packed size of entire buffer full of id_map
-  static size_t packed_size_id_map(MPI_Comm comm) {
+  /// Unique strings with ids below count, copied under the lock.  Ids are
+  /// assigned in order and never reused, so these stay the same even as
+  /// other threads add values.
+  static void get_id_prefix(size_t count, std::vector<const std::string*>& ids) {
+    ScopedLock guard(get_lock());
+    std::vector<const std::string*>& table = get_id_table();
+    if (count > table.size()) count = table.size();
+    ids.assign(table.begin(), table.begin() + count);
+  }
+
+  /// packed size of entire buffer full of id_map.  Values may be added by
+  /// other threads (e.g. a background resolver) between sizing and packing,
+  /// so pass the same count, taken from num_ids() after the values to be
+  /// sent were created, to this and to pack_id_map().
+  static size_t packed_size_id_map(MPI_Comm comm, size_t count = num_ids()) {
+    std::vector<const std::string*> ids;
+    get_id_prefix(count, ids);
+
     size_t size = 0;
     size += pmpi_packed_size(1, MPI_INT, comm);                // number of mappings
-
-    id_set& ids = get_identifiers();
-    for (id_set_iterator i=ids.begin(); i != ids.end(); i++) {
-      size += pmpi_packed_size(1, MPI_UINTPTR_T, comm);     // local addr of module string
-      size += UniqueId<Derived>(*i).packed_size(comm);     // size of raw string
+    for (size_t i=0; i < ids.size(); i++) {
+      size += pmpi_packed_size(1, MPI_UINT32_T, comm);      // local id of module string
+      size += UniqueId<Derived>(ids[i]).packed_size(comm);  // size of raw string
     }
     return size;
   }
 
-  /// Sends all known pointer/identifier mappings to anther process.
-  static void pack_id_map(void *buf, int bufsize, int *position, MPI_Comm comm) {
-    int len = get_identifiers().size();
-    PMPI_Pack(&len, 1, MPI_INT, buf, bufsize, position, comm);
+  /// Sends id/identifier mappings for the first count ids to anther process.
+  static void pack_id_map(void *buf, int bufsize, int *position, MPI_Comm comm,
+                          size_t count = num_ids()) {
+    std::vector<const std::string*> ids;
+    get_id_prefix(count, ids);
 
-    id_set& ids = get_identifiers();
-    for (id_set_iterator i=ids.begin(); i != ids.end(); i++) {
-      std::string **addr = const_cast<std::string**>(&(*i));      // local addr of module string
-      PMPI_Pack(addr, 1, MPI_UINTPTR_T, buf, bufsize, position, comm);
-      UniqueId<Derived>(*i).pack(buf, bufsize, position, comm);   // raw string.
+    int len = ids.size();
+    PMPI_Pack(&len, 1, MPI_INT, buf, bufsize, position, comm);
+    for (size_t i=0; i < ids.size(); i++) {
+      UniqueId<Derived> uid(ids[i]);
+      uint32_t dense = uid.id();                                  // local id of module string
+      PMPI_Pack(&dense, 1, MPI_UINT32_T, buf, bufsize, position, comm);
+      uid.pack(buf, bufsize, position, comm);                     // raw string.
     }
   }
 
@@ -261,11 +342,11 @@ public:
     PMPI_Unpack(buf, bufsize, position, &len, 1, MPI_INT, comm);
 
     for (int i=0; i < len; i++) {
-      uintptr_t remote_addr;     // addr of string on remote machine
-      PMPI_Unpack(buf, bufsize, position, &remote_addr, 1, MPI_UINTPTR_T, comm);
+      uint32_t remote_id;        // id of string on remote machine
+      PMPI_Unpack(buf, bufsize, position, &remote_id, 1, MPI_UINT32_T, comm);
 
       // unpack, look up, and add mapping for raw identifier from remote process.
-      dest.insert(typename id_map::value_type(remote_addr, Derived::unpack(buf, bufsize, position, comm)));
+      dest.insert(typename id_map::value_type(remote_id, Derived::unpack(buf, bufsize, position, comm)));
     }
   }
 